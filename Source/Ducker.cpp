@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    Ducker.cpp
+
+  ==============================================================================
+*/
+
+#include "Ducker.h"
+
+//==============================================================================
+void Ducker::prepare (double newSampleRate, int maximumBlockSize)
+{
+    sampleRate = newSampleRate;
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+
+    scratch.allocate(static_cast<size_t>(maxBlockSize), true);
+
+    reset();
+}
+
+void Ducker::reset()
+{
+    envelope = 0.0f;
+}
+
+void Ducker::setParameters (float attackMs, float releaseMs, float thresholdDb, float newDepth)
+{
+    auto coefFor = [this] (float ms)
+    {
+        return 1.0f - std::exp(-1.0f / (juce::jmax(0.01f, ms) * 0.001f * static_cast<float>(sampleRate)));
+    };
+
+    attackCoef = coefFor(attackMs);
+    releaseCoef = coefFor(releaseMs);
+    threshold = juce::Decibels::decibelsToGain(thresholdDb);
+    depth = juce::jlimit(0.0f, 1.0f, newDepth);
+}
+
+//==============================================================================
+bool Ducker::process (const juce::AudioBuffer<float>& key, float* gains, int numSamples)
+{
+    bool ducking = false;
+
+    for (int start = 0; start < numSamples; start += maxBlockSize)
+    {
+        auto num = juce::jmin(maxBlockSize, numSamples - start);
+
+        if (processChunk(key, gains, start, num))
+            ducking = true;
+        else
+            juce::FloatVectorOperations::fill(gains + start, 1.0f, num);
+    }
+
+    return ducking;
+}
+
+bool Ducker::processChunk (const juce::AudioBuffer<float>& key, float* gains, int startSample, int numSamples)
+{
+    auto* level = gains + startSample;
+
+    // Key level: max |x| across channels
+    juce::FloatVectorOperations::clear(level, numSamples);
+
+    for (int channel = 0; channel < key.getNumChannels(); ++channel)
+    {
+        juce::FloatVectorOperations::abs(scratch.get(), key.getReadPointer(channel, startSample), numSamples);
+        juce::FloatVectorOperations::max(level, level, scratch.get(), numSamples);
+    }
+
+    // One-pole follower, picking attack or release without a branch
+    auto env = envelope;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto rising = static_cast<float>(level[i] > env);
+        env += (level[i] - env) * (releaseCoef + (attackCoef - releaseCoef) * rising);
+        level[i] = env;
+    }
+
+    envelope = env;
+
+    if (depth <= 0.0f || juce::FloatVectorOperations::findMaximum(level, numSamples) <= threshold)
+        return false;
+
+    // Ducking starts at the threshold and reaches full depth 6 dB above it
+    juce::FloatVectorOperations::add(level, -threshold, numSamples);
+    juce::FloatVectorOperations::multiply(level, 1.0f / threshold, numSamples);
+    juce::FloatVectorOperations::clip(level, level, 0.0f, 1.0f, numSamples);
+    juce::FloatVectorOperations::multiply(level, -depth, numSamples);
+    juce::FloatVectorOperations::add(level, 1.0f, numSamples);
+
+    return true;
+}
@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    Ducker.h
+
+    Envelope follower that turns a key signal (the sidechain, or the dry
+    input when there isn't one) into a gain curve for the wet signal.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+*/
+class Ducker
+{
+public:
+    Ducker() = default;
+
+    //==============================================================================
+    void prepare (double sampleRate, int maximumBlockSize);
+    void reset();
+
+    void setParameters (float attackMs, float releaseMs, float thresholdDb, float depth);
+
+    // Writes one gain per sample into `gains`. Returns false when they're all
+    // 1, so the caller can skip applying them.
+    bool process (const juce::AudioBuffer<float>& key, float* gains, int numSamples);
+
+private:
+    //==============================================================================
+    bool processChunk (const juce::AudioBuffer<float>& key, float* gains, int startSample, int numSamples);
+
+    double sampleRate = 44100.0;
+    int maxBlockSize = 0;
+
+    float attackCoef = 1.0f;
+    float releaseCoef = 1.0f;
+    float threshold = 1.0f;
+    float depth = 0.0f;
+
+    float envelope = 0.0f;
+
+    juce::HeapBlock<float> scratch;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Ducker)
+};
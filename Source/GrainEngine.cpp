@@ -0,0 +1,212 @@
+/*
+  ==============================================================================
+
+    GrainEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "GrainEngine.h"
+
+//==============================================================================
+// Adds one grain into dest. The read position is split into an integer
+// base index and a small float offset from it, so the fraction keeps its
+// precision however big the ring is. Positions are computed from the sample
+// index rather than accumulated, and dest can't alias the history, so this
+// is a plain gather-and-add the compiler can vectorize.
+static void accumulateGrain (float* __restrict dest, const float* __restrict src, int mask,
+                             const float* __restrict window, float windowSize, int numSamples,
+                             int base, float offset, float offsetStep, float p0, float pStep, float amp)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto fi = static_cast<float>(i);
+        auto readOffset = offset + fi * offsetStep; // never negative, so truncating floors it
+        auto whole = static_cast<int>(readOffset);
+        auto frac = readOffset - static_cast<float>(whole);
+        auto index = base + whole;
+
+        auto a = src[index & mask];
+        auto b = src[(index + 1) & mask];
+        auto w = window[static_cast<int>((p0 + fi * pStep) * windowSize)];
+
+        dest[i] += amp * w * (a + frac * (b - a));
+    }
+}
+
+//==============================================================================
+GrainEngine::GrainEngine()
+{
+    // Hann window, with a guard point at the end
+    for (int i = 0; i <= windowSize; ++i)
+        window[i] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * static_cast<float>(i) / static_cast<float>(windowSize));
+}
+
+//==============================================================================
+void GrainEngine::prepare (double newSampleRate, int numChannels, double maxHistorySeconds)
+{
+    sampleRate = newSampleRate;
+
+    auto size = juce::nextPowerOfTwo(static_cast<int>(std::ceil(maxHistorySeconds * sampleRate)));
+    history.setSize(numChannels, size);
+    historyMask = size - 1;
+
+    reset();
+}
+
+void GrainEngine::reset()
+{
+    history.clear();
+    writePos = 0;
+    clearVoices();
+}
+
+void GrainEngine::clearVoices()
+{
+    numActive = 0;
+    samplesToNextGrain = 0.0f;
+}
+
+void GrainEngine::setParameters (float grainSizeMs, float density, float pitchSemitones,
+                                 float newJitter, float delayInSamples, bool reverse)
+{
+    grainLength = juce::jmax(16.0f, grainSizeMs * 0.001f * static_cast<float>(sampleRate));
+    grainInterval = static_cast<float>(sampleRate) / juce::jmax(0.1f, density);
+    rate = std::pow(2.0f, pitchSemitones / 12.0f);
+    jitter = juce::jlimit(0.0f, 1.0f, newJitter);
+    baseDelay = delayInSamples;
+    reversed = reverse;
+
+    // Hann grains at 50% overlap sum to 1, so scale down past that
+    grainGain = juce::jmin(1.0f, 2.0f * grainInterval / grainLength);
+}
+
+//==============================================================================
+void GrainEngine::pushHistory (const juce::AudioBuffer<float>& block, int numSamples)
+{
+    auto size = historyMask + 1;
+    auto numChannels = juce::jmin(block.getNumChannels(), history.getNumChannels());
+
+    // Anything longer than the history would only overwrite itself
+    auto offset = juce::jmax(0, numSamples - size);
+    auto num = numSamples - offset;
+    auto pos = (writePos + offset) & historyMask;
+    auto firstPart = juce::jmin(num, size - pos);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* src = block.getReadPointer(channel, offset);
+        history.copyFrom(channel, pos, src, firstPart);
+
+        if (num > firstPart)
+            history.copyFrom(channel, 0, src + firstPart, num - firstPart);
+    }
+
+    writePos = (writePos + numSamples) & historyMask;
+}
+
+void GrainEngine::render (juce::AudioBuffer<float>& output, int numSamples)
+{
+    output.clear(0, numSamples);
+
+    // Render whatever is playing up to the next grain start, then start it
+    int pos = 0;
+
+    while (pos < numSamples)
+    {
+        auto num = juce::jlimit(0, numSamples - pos, static_cast<int>(std::ceil(samplesToNextGrain)));
+
+        if (num > 0)
+        {
+            renderSegment(output, pos, num, numSamples);
+            samplesToNextGrain -= static_cast<float>(num);
+            pos += num;
+        }
+
+        if (samplesToNextGrain <= 0.0f)
+        {
+            startGrain();
+            samplesToNextGrain += grainInterval * (1.0f + jitter * (random.nextFloat() - 0.5f));
+        }
+    }
+}
+
+//==============================================================================
+void GrainEngine::renderSegment (juce::AudioBuffer<float>& output, int startSample, int numSamples, int blockSize)
+{
+    // Write head position of the segment's first sample
+    auto now = writePos - blockSize + startSample;
+
+    for (int g = numActive; --g >= 0;)
+    {
+        auto num = juce::jmin(numSamples, remaining[g]);
+        auto dStep = delayStep[g];
+        auto p0 = startPhase[g], pStep = phaseStep[g];
+        auto amp = gain[g];
+        auto numChannels = juce::jmin(output.getNumChannels(), history.getNumChannels());
+
+        // Sample i reads at now - delayWhole + (i * (1 - dStep) - delayFrac).
+        // When the read head falls behind, that offset goes negative, so
+        // move the base back far enough to keep it positive.
+        auto offsetStep = 1.0f - dStep;
+        auto bias = 1 + static_cast<int>(std::ceil(static_cast<float>(num) * juce::jmax(0.0f, -offsetStep)));
+        auto base = now - delayWhole[g] - bias;
+        auto offset = static_cast<float>(bias) - delayFrac[g];
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            accumulateGrain(output.getWritePointer(channel, startSample), history.getReadPointer(channel), historyMask,
+                            window, static_cast<float>(windowSize), num, base, offset, offsetStep, p0, pStep, amp);
+
+        // Once per segment, so double doesn't cost anything and stops drift
+        auto delay = static_cast<double>(delayFrac[g]) + static_cast<double>(num) * static_cast<double>(dStep);
+        auto whole = static_cast<int>(std::floor(delay));
+        delayWhole[g] += whole;
+        delayFrac[g] = static_cast<float>(delay - static_cast<double>(whole));
+        startPhase[g] = p0 + static_cast<float>(num) * pStep;
+        remaining[g] -= num;
+
+        if (remaining[g] <= 0)
+            removeGrain(g);
+    }
+}
+
+void GrainEngine::startGrain()
+{
+    if (numActive == maxGrains || history.getNumChannels() == 0)
+        return; // pool is full (or not prepared), skip this one
+
+    auto length = static_cast<int>(grainLength);
+    auto g = numActive++;
+
+    // Forwards the read head moves at `rate` while the write head moves at 1,
+    // backwards it moves away at 1 + rate
+    auto step = reversed ? 1.0f + rate : 1.0f - rate;
+    auto travel = step * static_cast<float>(length);
+
+    auto delay = baseDelay + jitter * random.nextFloat() * grainLength;
+    auto minDelay = 2.0f - juce::jmin(0.0f, travel);                        // never read ahead of the write head
+    auto maxDelay = static_cast<float>(historyMask - 2) - juce::jmax(0.0f, travel); // or off the end of the history
+
+    delay = juce::jlimit(minDelay, juce::jmax(minDelay, maxDelay), delay);
+    delayWhole[g] = static_cast<int>(delay);
+    delayFrac[g] = delay - static_cast<float>(delayWhole[g]);
+    delayStep[g] = step;
+    startPhase[g] = 0.0f;
+    phaseStep[g] = 1.0f / static_cast<float>(length);
+    gain[g] = grainGain;
+    remaining[g] = length;
+}
+
+void GrainEngine::removeGrain (int index)
+{
+    // Keep the active voices packed at the front
+    auto last = --numActive;
+
+    delayWhole[index] = delayWhole[last];
+    delayFrac[index] = delayFrac[last];
+    delayStep[index] = delayStep[last];
+    startPhase[index] = startPhase[last];
+    phaseStep[index] = phaseStep[last];
+    gain[index] = gain[last];
+    remaining[index] = remaining[last];
+}
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    GrainEngine.h
+
+    Plays the echo history back as overlapping grains, forwards (pitched)
+    or reversed. All voices live in a fixed pool that's allocated in
+    prepare(), so nothing touches the heap on the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+*/
+class GrainEngine
+{
+public:
+    GrainEngine();
+
+    //==============================================================================
+    void prepare (double sampleRate, int numChannels, double maxHistorySeconds);
+    void reset();
+
+    // Drops any playing grains but keeps the history, for when grains start
+    // again after a while of not being rendered.
+    void clearVoices();
+
+    void setParameters (float grainSizeMs, float density, float pitchSemitones,
+                        float jitter, float delayInSamples, bool reverse);
+
+    // Appends a block to the history. This should get the same samples that
+    // are pushed into the delay line.
+    void pushHistory (const juce::AudioBuffer<float>& block, int numSamples);
+
+    // Replaces the buffer's contents with the grains for the block that was
+    // last pushed.
+    void render (juce::AudioBuffer<float>& output, int numSamples);
+
+    static constexpr int maxGrains = 128;
+
+private:
+    //==============================================================================
+    void renderSegment (juce::AudioBuffer<float>& output, int startSample, int numSamples, int blockSize);
+    void startGrain();
+    void removeGrain (int index);
+
+    static constexpr int windowSize = 1024;
+    float window[windowSize + 1];
+
+    double sampleRate = 44100.0;
+
+    juce::AudioBuffer<float> history; // power of two, so indices wrap with a mask
+    int historyMask = 0;
+    int writePos = 0;
+
+    float grainLength = 0.0f;   // samples
+    float grainInterval = 0.0f; // samples between grain starts
+    float rate = 1.0f;
+    float jitter = 0.0f;
+    float baseDelay = 0.0f;
+    float grainGain = 1.0f;
+    bool reversed = false;
+
+    float samplesToNextGrain = 0.0f;
+
+    // Voice state, structure-of-arrays. Only the first numActive are playing.
+    int delayWhole[maxGrains];     // read position, in samples behind the write head,
+    float delayFrac[maxGrains];    // split so the fraction doesn't lose precision
+    float delayStep[maxGrains];    // how much further behind it falls each sample
+    float startPhase[maxGrains];   // position in the window, 0..1
+    float phaseStep[maxGrains];
+    float gain[maxGrains];
+    int remaining[maxGrains];
+    int numActive = 0;
+
+    juce::Random random;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GrainEngine)
+};
@@ -55,14 +55,69 @@ Echo1AudioProcessorEditor::Echo1AudioProcessorEditor (Echo1AudioProcessor& p)
     addAndMakeVisible(roomSizeSlider);
     roomSizeSlider.addListener(this);
     
+    //====================== Ducking knobs ========================
+    
+    for ( auto* knob : knobs ){
+        knob->setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
+        knob->setTextBoxStyle(juce::Slider::NoTextBox, false, 90, 0);
+        knob->setColour(juce::Slider::rotarySliderFillColourId, juce::Colours::violet);
+        knob->setColour(juce::Slider::rotarySliderOutlineColourId, juce::Colours::silver);
+        knob->setColour(juce::Slider::thumbColourId, juce::Colours::skyblue);
+        addAndMakeVisible(knob);
+        knob->addListener(this);
+    }
+    
+    duckAttackSlider.setRange(0.1, 100.0);
+    duckAttackSlider.setSkewFactor(0.4);
+    
+    duckReleaseSlider.setRange(10.0, 2000.0);
+    duckReleaseSlider.setSkewFactor(0.4);
+    
+    duckThresholdSlider.setRange(-60.0, 0.0);
+    
+    duckDepthSlider.setRange(0.0, 1.0);
+    
+    //====================== Grain controls =======================
+    
+    grainSizeSlider.setRange(10.0, 500.0);
+    grainSizeSlider.setSkewFactor(0.5);
+    
+    grainDensitySlider.setRange(1.0, 200.0);
+    grainDensitySlider.setSkewFactor(0.4);
+    
+    grainPitchSlider.setRange(-12.0, 12.0, 1.0);
+    
+    grainJitterSlider.setRange(0.0, 1.0);
+    
+    echoModeBox.addItem("Echo", Echo1AudioProcessor::normalEcho + 1);
+    echoModeBox.addItem("Reverse", Echo1AudioProcessor::reverseEcho + 1);
+    echoModeBox.addItem("Grains", Echo1AudioProcessor::granularEcho + 1);
+    echoModeBox.setColour(juce::ComboBox::backgroundColourId, juce::Colours::white);
+    echoModeBox.setColour(juce::ComboBox::textColourId, juce::Colours::violet);
+    echoModeBox.setColour(juce::ComboBox::outlineColourId, juce::Colours::silver);
+    echoModeBox.setColour(juce::ComboBox::arrowColourId, juce::Colours::violet);
+    echoModeBox.onChange = [this] { audioProcessor.setEchoMode(echoModeBox.getSelectedId() - 1); };
+    addAndMakeVisible(echoModeBox);
+    
     //==================== Restore State ==========================
     
     dryWetSlider.setValue(*audioProcessor.getDryWet());
     decayTimeSlider.setValue(*audioProcessor.getDecayTime());
     roomSizeSlider.setValue(*audioProcessor.getRoomSize());
     
+    duckAttackSlider.setValue(*audioProcessor.getDuckAttack());
+    duckReleaseSlider.setValue(*audioProcessor.getDuckRelease());
+    duckThresholdSlider.setValue(*audioProcessor.getDuckThreshold());
+    duckDepthSlider.setValue(*audioProcessor.getDuckDepth());
     
-    setSize(600, 400);
+    grainSizeSlider.setValue(*audioProcessor.getGrainSize());
+    grainDensitySlider.setValue(*audioProcessor.getGrainDensity());
+    grainPitchSlider.setValue(*audioProcessor.getGrainPitch());
+    grainJitterSlider.setValue(*audioProcessor.getGrainJitter());
+    echoModeBox.setSelectedId(*audioProcessor.getEchoMode() + 1, juce::dontSendNotification);
+    
+    
+    setSize(600, 560);
     startTimerHz(30);
    
 }
@@ -77,6 +132,9 @@ Echo1AudioProcessorEditor::~Echo1AudioProcessorEditor()
         slider->removeListener(this);
         slider->setLookAndFeel(nullptr);
     }
+    for ( auto* knob : knobs ) {
+        knob->removeListener(this);
+    }
     stopTimer();
     
 //    dryWetSlider.setLookAndFeel(nullptr);
@@ -93,6 +151,22 @@ void Echo1AudioProcessorEditor::sliderValueChanged(juce::Slider* slider)
         audioProcessor.setDecayTime( decayTimeSlider.getValue() );
     } else if (slider == &roomSizeSlider) {
         audioProcessor.setRoomSize( roomSizeSlider.getValue() );
+    } else if (slider == &duckAttackSlider) {
+        audioProcessor.setDuckAttack( duckAttackSlider.getValue() );
+    } else if (slider == &duckReleaseSlider) {
+        audioProcessor.setDuckRelease( duckReleaseSlider.getValue() );
+    } else if (slider == &duckThresholdSlider) {
+        audioProcessor.setDuckThreshold( duckThresholdSlider.getValue() );
+    } else if (slider == &duckDepthSlider) {
+        audioProcessor.setDuckDepth( duckDepthSlider.getValue() );
+    } else if (slider == &grainSizeSlider) {
+        audioProcessor.setGrainSize( grainSizeSlider.getValue() );
+    } else if (slider == &grainDensitySlider) {
+        audioProcessor.setGrainDensity( grainDensitySlider.getValue() );
+    } else if (slider == &grainPitchSlider) {
+        audioProcessor.setGrainPitch( grainPitchSlider.getValue() );
+    } else if (slider == &grainJitterSlider) {
+        audioProcessor.setGrainJitter( grainJitterSlider.getValue() );
     }
     repaint();
     
@@ -125,6 +199,19 @@ void Echo1AudioProcessorEditor::paint (juce::Graphics& g)
     g.drawFittedText("Short", bottomMiddleLabelRect.toNearestInt(), juce::Justification::centredTop, 1);
     g.drawFittedText("Room", bottomRightLabelRect.toNearestInt(), juce::Justification::centredTop, 1);
     
+    g.setColour(lighterpurple);
+    g.drawFittedText("Attack", duckAttackRect.toNearestInt(), juce::Justification::centredBottom, 1);
+    g.drawFittedText("Release", duckReleaseRect.toNearestInt(), juce::Justification::centredBottom, 1);
+    g.drawFittedText("Threshold", duckThresholdRect.toNearestInt(), juce::Justification::centredBottom, 1);
+    g.drawFittedText("Duck", duckDepthRect.toNearestInt(), juce::Justification::centredBottom, 1);
+    
+    g.setColour(juce::Colours::skyblue);
+    g.drawFittedText("Mode", echoModeRect.toNearestInt(), juce::Justification::centredBottom, 1);
+    g.drawFittedText("Size", grainSizeRect.toNearestInt(), juce::Justification::centredBottom, 1);
+    g.drawFittedText("Density", grainDensityRect.toNearestInt(), juce::Justification::centredBottom, 1);
+    g.drawFittedText("Pitch", grainPitchRect.toNearestInt(), juce::Justification::centredBottom, 1);
+    g.drawFittedText("Jitter", grainJitterRect.toNearestInt(), juce::Justification::centredBottom, 1);
+    
     //========================== verbWindow ============================
    
     g.setColour(juce::Colours::white);
@@ -209,6 +296,19 @@ void Echo1AudioProcessorEditor::resized()
     //=========================== Rectangle Stuff ==============================
     auto bounds = getLocalBounds().toFloat();
     
+    duckRect = bounds.removeFromBottom( 80.f );
+        duckAttackRect = duckRect.removeFromLeft( duckRect.getWidth() / 4 );
+        duckReleaseRect = duckRect.removeFromLeft( duckRect.getWidth() / 3 );
+        duckThresholdRect = duckRect.removeFromLeft( duckRect.getWidth() / 2 );
+        duckDepthRect = duckRect;
+    
+    grainRect = bounds.removeFromBottom( 80.f );
+        echoModeRect = grainRect.removeFromLeft( grainRect.getWidth() / 5 );
+        grainSizeRect = grainRect.removeFromLeft( grainRect.getWidth() / 4 );
+        grainDensityRect = grainRect.removeFromLeft( grainRect.getWidth() / 3 );
+        grainPitchRect = grainRect.removeFromLeft( grainRect.getWidth() / 2 );
+        grainJitterRect = grainRect;
+    
     leftRect = bounds.removeFromLeft( bounds.getWidth() / 3 );
         topLabelRect = leftRect.removeFromTop( leftRect.getHeight() / 8 );
             topLeftLabelRect = topLabelRect.removeFromLeft( topLabelRect.getWidth() / 3 );
@@ -239,4 +339,15 @@ void Echo1AudioProcessorEditor::resized()
     dryWetSlider.setBounds(dryWetRect.toNearestInt());
     decayTimeSlider.setBounds(decayTimeRect.toNearestInt());
     roomSizeSlider.setBounds(roomSizeRect.toNearestInt());
+    
+    duckAttackSlider.setBounds(duckAttackRect.withTrimmedBottom(20.f).toNearestInt());
+    duckReleaseSlider.setBounds(duckReleaseRect.withTrimmedBottom(20.f).toNearestInt());
+    duckThresholdSlider.setBounds(duckThresholdRect.withTrimmedBottom(20.f).toNearestInt());
+    duckDepthSlider.setBounds(duckDepthRect.withTrimmedBottom(20.f).toNearestInt());
+    
+    echoModeBox.setBounds(echoModeRect.withTrimmedBottom(20.f).withSizeKeepingCentre(100.f, 24.f).toNearestInt());
+    grainSizeSlider.setBounds(grainSizeRect.withTrimmedBottom(20.f).toNearestInt());
+    grainDensitySlider.setBounds(grainDensityRect.withTrimmedBottom(20.f).toNearestInt());
+    grainPitchSlider.setBounds(grainPitchRect.withTrimmedBottom(20.f).toNearestInt());
+    grainJitterSlider.setBounds(grainJitterRect.withTrimmedBottom(20.f).toNearestInt());
 }
@@ -84,6 +84,19 @@ private:
         juce::Rectangle<float> verbWindow;
         float cornerRadius = 15.0f;
     
+    juce::Rectangle<float> duckRect;
+        juce::Rectangle<float> duckAttackRect;
+        juce::Rectangle<float> duckReleaseRect;
+        juce::Rectangle<float> duckThresholdRect;
+        juce::Rectangle<float> duckDepthRect;
+    
+    juce::Rectangle<float> grainRect;
+        juce::Rectangle<float> echoModeRect;
+        juce::Rectangle<float> grainSizeRect;
+        juce::Rectangle<float> grainDensityRect;
+        juce::Rectangle<float> grainPitchRect;
+        juce::Rectangle<float> grainJitterRect;
+    
     //============================ Slider stuff ===============================
     
     juce::Slider dryWetSlider;
@@ -94,6 +107,21 @@ private:
     
     std::vector<juce::Slider*> sliders = {&dryWetSlider, &decayTimeSlider, &roomSizeSlider};
     
+    juce::Slider duckAttackSlider;
+    juce::Slider duckReleaseSlider;
+    juce::Slider duckThresholdSlider;
+    juce::Slider duckDepthSlider;
+    
+    juce::Slider grainSizeSlider;
+    juce::Slider grainDensitySlider;
+    juce::Slider grainPitchSlider;
+    juce::Slider grainJitterSlider;
+    
+    std::vector<juce::Slider*> knobs = {&duckAttackSlider, &duckReleaseSlider, &duckThresholdSlider, &duckDepthSlider,
+                                        &grainSizeSlider, &grainDensitySlider, &grainPitchSlider, &grainJitterSlider};
+    
+    juce::ComboBox echoModeBox;
+    
     std::unique_ptr<CustomLookAndFeel> customLookAndFeel;
 
     
@@ -16,6 +16,7 @@ Echo1AudioProcessor::Echo1AudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
@@ -99,8 +100,19 @@ void Echo1AudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
     int maxDelayInSamples = static_cast<int>(2.0 * sampleRate); // Maximum 2 seconds delay
 
         // Resize the delay line to match the number of input channels
-        delayLine.prepare({ sampleRate, static_cast<juce::uint32>(samplesPerBlock), static_cast<juce::uint32>(getTotalNumInputChannels()) });
+        delayLine.prepare({ sampleRate, static_cast<juce::uint32>(samplesPerBlock), static_cast<juce::uint32>(getMainBusNumInputChannels()) });
         delayLine.setMaximumDelayInSamples(maxDelayInSamples);
+
+    dryBuffer.setSize(getMainBusNumInputChannels(), samplesPerBlock);
+    sendBuffer.setSize(getMainBusNumInputChannels(), samplesPerBlock);
+    duckGains.setSize(1, samplesPerBlock);
+    ducker.prepare(sampleRate, samplesPerBlock);
+
+    grainBuffer.setSize(getMainBusNumInputChannels(), samplesPerBlock);
+    grains.prepare(sampleRate, getMainBusNumInputChannels(), 2.0); // same 2 seconds as the delay line
+
+    limiter.prepare(sampleRate, samplesPerBlock, getMainBusNumOutputChannels());
+    setLatencySamples(limiter.getLatencyInSamples());
 }
 
 void Echo1AudioProcessor::releaseResources()
@@ -128,6 +140,17 @@ bool Echo1AudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) co
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+
+    // The sidechain is optional, but if it's there it has to be mono or stereo
+    if (layouts.inputBuses.size() > 1)
+    {
+        auto sidechain = layouts.getChannelSet(true, 1);
+
+        if (! sidechain.isDisabled()
+         && sidechain != juce::AudioChannelSet::mono()
+         && sidechain != juce::AudioChannelSet::stereo())
+            return false;
+    }
    #endif
 
     return true;
@@ -138,54 +161,148 @@ bool Echo1AudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) co
 void Echo1AudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    auto totalNumInputChannels = getMainBusNumInputChannels();
+    auto totalNumOutputChannels = getMainBusNumOutputChannels();
+    auto numSamples = buffer.getNumSamples();
+
+    // The sidechain channels come after the main ones, keep them out of the way
+    auto mainBuffer = getBusBuffer(buffer, false, 0);
 
     // Clear any extra output channels
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear(i, 0, buffer.getNumSamples());
+        mainBuffer.clear(i, 0, numSamples);
 
     jassert(totalNumInputChannels == 2 && totalNumOutputChannels == 2); // Ensure stereo
 
-    // Configure reverb parameters
+    // Only reallocates if the host sends a bigger block than it promised
+    dryBuffer.setSize(totalNumInputChannels, numSamples, false, false, true);
+    sendBuffer.setSize(totalNumInputChannels, numSamples, false, false, true);
+    duckGains.setSize(1, numSamples, false, false, true);
+    grainBuffer.setSize(totalNumInputChannels, numSamples, false, false, true);
+
+    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+        dryBuffer.copyFrom(channel, 0, mainBuffer, channel, 0, numSamples);
+
+    // Configure reverb parameters. The reverb only makes the wet part, its dry
+    // path is mixed back in below so the ducker can leave it alone.
     juce::Reverb::Parameters reverbParams;
     reverbParams.roomSize = *getRoomSize();
     reverbParams.damping = *getDryWet() / 2.f;
     reverbParams.wetLevel = *getDryWet();
-    reverbParams.dryLevel = 1.0f - *getDryWet();
+    reverbParams.dryLevel = 0.0f;
     reverbParams.freezeMode = 0.0f;
     reverb.setParameters(reverbParams);
 
+    // juce::Reverb scales its dry level by 2, keep the same balance
+    float sendLevel = 2.0f * (1.0f - *getDryWet());
+    float dryLevel = sendLevel * (1.0f - *getDryWet()); // how much of the output is untouched input
+
     // Calculate and set delay time
     float decayTime = juce::jlimit(0.1f, 0.8f, *getDecayTime());
     float delayTime = juce::jmap(decayTime, 0.1f, 1.0f, 50.0f, 500.0f); // Map decay time to delay time
-    delayLine.setDelay(getSampleRate() * (delayTime / 1000.0f));
+    float delayInSamples = static_cast<float>(getSampleRate()) * (delayTime / 1000.0f);
+    delayLine.setDelay(delayInSamples);
     
     // Process the delay with feedback
-    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    for (int channel = 0; channel < mainBuffer.getNumChannels(); ++channel)
     {
-        auto* channelData = buffer.getWritePointer(channel);
+        auto* channelData = mainBuffer.getWritePointer(channel);
+        auto* grainInput = grainBuffer.getWritePointer(channel);
 
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+        for (int sample = 0; sample < numSamples; ++sample)
         {
             float delayedSample = delayLine.popSample(channel); // Get delayed output
             float inputSample = channelData[sample] + delayedSample * juce::jlimit(0.0f, 0.95f, *getDecayTime()); // Add feedback to input
             delayLine.pushSample(channel, inputSample); // Feed back into delay line
+            grainInput[sample] = inputSample;
             channelData[sample] = (1.0f - *getDryWet()) * channelData[sample] + *getDryWet() * delayedSample; // Dry/wet mix
         }
     }
     
+    // The grains always get the history so switching modes doesn't start from silence
+    grains.pushHistory(grainBuffer, numSamples);
+    
+    // Reverse / granular: the grains replace the plain echo in the wet signal,
+    // the feedback loop above keeps running as normal
+    int mode = *getEchoMode();
+    bool grainsNow = mode != normalEcho;
+    bool grainsBefore = lastEchoMode != normalEcho;
+    
+    // Voices left over from last time are at stale positions, start fresh
+    if (grainsNow && ! grainsBefore)
+        grains.clearVoices();
+    
+    // Grains also play through the block that fades them out
+    if (grainsNow || grainsBefore)
+    {
+        grains.setParameters(*getGrainSize(), *getGrainDensity(), *getGrainPitch(), *getGrainJitter(),
+                             delayInSamples, (grainsNow ? mode : lastEchoMode) == reverseEcho);
+        grains.render(grainBuffer, numSamples);
+        
+        for (int channel = 0; channel < mainBuffer.getNumChannels(); ++channel)
+        {
+            // Same dry/wet mix as the echo, with the grains as the wet
+            auto* grainData = grainBuffer.getWritePointer(channel);
+            juce::FloatVectorOperations::multiply(grainData, *getDryWet(), numSamples);
+            juce::FloatVectorOperations::addWithMultiply(grainData, dryBuffer.getReadPointer(channel), 1.0f - *getDryWet(), numSamples);
+            
+            if (grainsNow && grainsBefore)
+            {
+                mainBuffer.copyFrom(channel, 0, grainBuffer, channel, 0, numSamples);
+            }
+            else
+            {
+                // Mode changed: crossfade between the echo and the grains over this block
+                float echoStart = grainsNow ? 1.0f : 0.0f;
+                mainBuffer.applyGainRamp(channel, 0, numSamples, echoStart, 1.0f - echoStart);
+                mainBuffer.addFromWithRamp(channel, 0, grainData, numSamples, 1.0f - echoStart, echoStart);
+            }
+        }
+    }
+    
+    lastEchoMode = mode;
+    
+    for (int channel = 0; channel < mainBuffer.getNumChannels(); ++channel)
+        sendBuffer.copyFrom(channel, 0, mainBuffer, channel, 0, numSamples);
+    
     // Process reverb (optional)
-    auto* leftChannel = buffer.getWritePointer(0);
-    auto* rightChannel = buffer.getWritePointer(1);
-    reverb.processStereo(leftChannel, rightChannel, buffer.getNumSamples());
+    auto* leftChannel = mainBuffer.getWritePointer(0);
+    auto* rightChannel = mainBuffer.getWritePointer(1);
+    reverb.processStereo(leftChannel, rightChannel, numSamples);
+    
+    // Duck the echoes and the reverb off the sidechain, or the dry input without one
+    ducker.setParameters(*getDuckAttack(), *getDuckRelease(), *getDuckThreshold(), *getDuckDepth());
+    
+    auto* sidechainBus = getBus(true, 1);
+    bool useSidechain = sidechainBus != nullptr && sidechainBus->isEnabled() && sidechainBus->getNumberOfChannels() > 0;
+    bool ducking = useSidechain ? ducker.process(getBusBuffer(buffer, true, 1), duckGains.getWritePointer(0), numSamples)
+                                : ducker.process(dryBuffer, duckGains.getWritePointer(0), numSamples);
+    
+    for (int channel = 0; channel < mainBuffer.getNumChannels(); ++channel)
+    {
+        auto* channelData = mainBuffer.getWritePointer(channel);
+        
+        // Reverb tail plus the reverb's dry path
+        juce::FloatVectorOperations::addWithMultiply(channelData, sendBuffer.getReadPointer(channel), sendLevel, numSamples);
+        
+        if (ducking)
+        {
+            // Take the untouched input out, duck what's left, and put it back
+            juce::FloatVectorOperations::addWithMultiply(channelData, dryBuffer.getReadPointer(channel), -dryLevel, numSamples);
+            juce::FloatVectorOperations::multiply(channelData, duckGains.getReadPointer(0), numSamples);
+            juce::FloatVectorOperations::addWithMultiply(channelData, dryBuffer.getReadPointer(channel), dryLevel, numSamples);
+        }
+    }
+    
+    // True-peak safety limiter, last thing before the meter
+    limiter.process(mainBuffer);
     
     float rmsLevel = 0.0f;
 
-        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        for (int channel = 0; channel < mainBuffer.getNumChannels(); ++channel)
         {
-            auto* channelData = buffer.getReadPointer(channel);
-            for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+            auto* channelData = mainBuffer.getReadPointer(channel);
+            for (int sample = 0; sample < numSamples; ++sample)
             {
                 rmsLevel += channelData[sample] * channelData[sample]; // Sum of squares
             }
@@ -193,7 +310,7 @@ void Echo1AudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::M
     
 
     // Normalize by the total number of samples
-    rmsLevel = std::sqrt(rmsLevel / (buffer.getNumSamples() * buffer.getNumChannels()));
+    rmsLevel = std::sqrt(rmsLevel / (numSamples * mainBuffer.getNumChannels()));
     // Store the calculated volume level
     setVolume(juce::jlimit(0.0f, 1.0f, rmsLevel));
     //DBG("Volume: " << volume << "      ");
@@ -221,6 +338,15 @@ void Echo1AudioProcessor::getStateInformation(juce::MemoryBlock& destData)
     state.setProperty("dryWet", dryWet, nullptr);
     state.setProperty("decayTime", decayTime, nullptr);
     state.setProperty("roomSize", roomSize, nullptr);
+    state.setProperty("duckAttack", duckAttack, nullptr);
+    state.setProperty("duckRelease", duckRelease, nullptr);
+    state.setProperty("duckThreshold", duckThreshold, nullptr);
+    state.setProperty("duckDepth", duckDepth, nullptr);
+    state.setProperty("echoMode", echoMode, nullptr);
+    state.setProperty("grainSize", grainSize, nullptr);
+    state.setProperty("grainDensity", grainDensity, nullptr);
+    state.setProperty("grainPitch", grainPitch, nullptr);
+    state.setProperty("grainJitter", grainJitter, nullptr);
     
     // Write the ValueTree to a stream
     juce::MemoryOutputStream stream(destData, true);
@@ -238,6 +364,15 @@ void Echo1AudioProcessor::setStateInformation(const void* data, int sizeInBytes)
         dryWet = state.getProperty("dryWet", 0.05f);
         decayTime = state.getProperty("decayTime", 0.0f);
         roomSize = state.getProperty("roomSize", 0.1f);
+        duckAttack = state.getProperty("duckAttack", 10.0f);
+        duckRelease = state.getProperty("duckRelease", 250.0f);
+        duckThreshold = state.getProperty("duckThreshold", -30.0f);
+        duckDepth = state.getProperty("duckDepth", 0.0f);
+        echoMode = state.getProperty("echoMode", static_cast<int>(normalEcho));
+        grainSize = state.getProperty("grainSize", 100.0f);
+        grainDensity = state.getProperty("grainDensity", 20.0f);
+        grainPitch = state.getProperty("grainPitch", 0.0f);
+        grainJitter = state.getProperty("grainJitter", 0.2f);
     }
 }
 
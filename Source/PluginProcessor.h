@@ -9,6 +9,9 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "TruePeakLimiter.h"
+#include "Ducker.h"
+#include "GrainEngine.h"
 
 //==============================================================================
 /**
@@ -83,6 +86,66 @@ public:
         
     }
     
+    //=============================== Ducking ======================================
+    
+    float* getDuckAttack() { return &duckAttack; }
+    void setDuckAttack(float val)
+    {
+        duckAttack = juce::jlimit(0.1f, 100.0f, val); // ms
+    }
+    
+    float* getDuckRelease() { return &duckRelease; }
+    void setDuckRelease(float val)
+    {
+        duckRelease = juce::jlimit(10.0f, 2000.0f, val); // ms
+    }
+    
+    float* getDuckThreshold() { return &duckThreshold; }
+    void setDuckThreshold(float val)
+    {
+        duckThreshold = juce::jlimit(-60.0f, 0.0f, val); // dB
+    }
+    
+    float* getDuckDepth() { return &duckDepth; }
+    void setDuckDepth(float val)
+    {
+        duckDepth = juce::jlimit(0.0f, 1.0f, val);
+    }
+    
+    //============================= Echo mode / Grains =============================
+    
+    enum EchoMode { normalEcho = 0, reverseEcho, granularEcho };
+    
+    int* getEchoMode() { return &echoMode; }
+    void setEchoMode(int val)
+    {
+        echoMode = juce::jlimit(0, 2, val);
+    }
+    
+    float* getGrainSize() { return &grainSize; }
+    void setGrainSize(float val)
+    {
+        grainSize = juce::jlimit(10.0f, 500.0f, val); // ms
+    }
+    
+    float* getGrainDensity() { return &grainDensity; }
+    void setGrainDensity(float val)
+    {
+        grainDensity = juce::jlimit(1.0f, 200.0f, val); // grains per second
+    }
+    
+    float* getGrainPitch() { return &grainPitch; }
+    void setGrainPitch(float val)
+    {
+        grainPitch = juce::jlimit(-12.0f, 12.0f, val); // semitones
+    }
+    
+    float* getGrainJitter() { return &grainJitter; }
+    void setGrainJitter(float val)
+    {
+        grainJitter = juce::jlimit(0.0f, 1.0f, val);
+    }
+    
     
 
 
@@ -92,10 +155,30 @@ private:
     float decayTime = 0.0f;
     float roomSize = 0.0f;
     float volume = 0.0f; // will be radius of plusing volume circle
+    
+    float duckAttack = 10.0f;
+    float duckRelease = 250.0f;
+    float duckThreshold = -30.0f;
+    float duckDepth = 0.0f; // 0 = ducking off
+    
+    int echoMode = normalEcho;
+    int lastEchoMode = normalEcho; // mode of the previous block, to fade between them
+    float grainSize = 100.0f;
+    float grainDensity = 20.0f;
+    float grainPitch = 0.0f;
+    float grainJitter = 0.2f;
     //float feedback = 0.5f;
     
     juce::Reverb reverb;
     juce::dsp::DelayLine<float> delayLine;
+    TruePeakLimiter limiter; // keeps runaway feedback off the bus
+    Ducker ducker;
+    GrainEngine grains; // reads a copy of what goes into delayLine
+    
+    juce::AudioBuffer<float> dryBuffer;  // input before the delay, ducking key when there's no sidechain
+    juce::AudioBuffer<float> sendBuffer; // what goes into the reverb
+    juce::AudioBuffer<float> duckGains;
+    juce::AudioBuffer<float> grainBuffer; // delay line input, then the grains
     
     
 
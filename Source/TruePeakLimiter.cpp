@@ -0,0 +1,197 @@
+/*
+  ==============================================================================
+
+    TruePeakLimiter.cpp
+
+  ==============================================================================
+*/
+
+#include "TruePeakLimiter.h"
+
+//==============================================================================
+TruePeakLimiter::TruePeakLimiter()
+{
+    // Hann windowed sinc for the three fractional phases (1/4, 2/4, 3/4).
+    // Phase 0 is just the input sample, so it doesn't need a filter.
+    for (int phase = 1; phase < oversampling; ++phase)
+    {
+        auto* coefs = phaseCoefs[phase - 1];
+        auto frac = static_cast<float>(phase) / static_cast<float>(oversampling);
+        float sum = 0.0f;
+
+        for (int k = 0; k < tapsPerPhase; ++k)
+        {
+            auto x = static_cast<float>(halfTaps - k) - frac;
+            auto sinc = juce::approximatelyEqual(x, 0.0f) ? 1.0f
+                                                           : std::sin(juce::MathConstants<float>::pi * x) / (juce::MathConstants<float>::pi * x);
+            auto window = 0.5f * (1.0f + std::cos(juce::MathConstants<float>::pi * x / static_cast<float>(halfTaps)));
+
+            coefs[k] = sinc * window;
+            sum += coefs[k];
+        }
+
+        for (int k = 0; k < tapsPerPhase; ++k)
+            coefs[k] /= sum; // unity gain at DC
+    }
+}
+
+//==============================================================================
+void TruePeakLimiter::prepare (double sampleRate, int maximumBlockSize, int numChannels)
+{
+    lookahead = juce::jmax(halfTaps, juce::roundToInt(sampleRate * 0.0015)); // 1.5 ms
+    latency = lookahead + halfTaps - 1;
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+
+    releaseCoef = 1.0f - std::exp(-1.0f / static_cast<float>(sampleRate * 0.06)); // 60 ms
+
+    delayBuffer.setSize(numChannels, latency + maxBlockSize);
+
+    peaks.allocate(static_cast<size_t>(maxBlockSize), true);
+    scratch.allocate(static_cast<size_t>(maxBlockSize), true);
+    gains.allocate(static_cast<size_t>(maxBlockSize), true);
+
+    minCapacity = lookahead + 2;
+    minValues.allocate(static_cast<size_t>(minCapacity), true);
+    minIndices.allocate(static_cast<size_t>(minCapacity), true);
+
+    rampValues.allocate(static_cast<size_t>(lookahead), true);
+
+    reset();
+}
+
+void TruePeakLimiter::reset()
+{
+    delayBuffer.clear();
+
+    envelope = 1.0f;
+    quietSamples = 2 * lookahead + 1;
+
+    minHead = 0;
+    minSize = 0;
+
+    juce::FloatVectorOperations::fill(rampValues.get(), 1.0f, lookahead);
+    rampPos = 0;
+    rampSum = static_cast<double>(lookahead);
+
+    sampleIndex = 0;
+}
+
+//==============================================================================
+void TruePeakLimiter::process (juce::AudioBuffer<float>& buffer)
+{
+    jassert(buffer.getNumChannels() <= delayBuffer.getNumChannels());
+
+    // Hosts are allowed to send bigger blocks than they promised
+    for (int start = 0; start < buffer.getNumSamples(); start += maxBlockSize)
+        processChunk(buffer, start, juce::jmin(maxBlockSize, buffer.getNumSamples() - start));
+}
+
+void TruePeakLimiter::processChunk (juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    auto numChannels = juce::jmin(buffer.getNumChannels(), delayBuffer.getNumChannels());
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        juce::FloatVectorOperations::copy(delayBuffer.getWritePointer(channel, latency),
+                                          buffer.getReadPointer(channel, startSample),
+                                          numSamples);
+
+    computePeaks(numChannels, numSamples);
+    auto limiting = computeGains(numSamples);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* output = buffer.getWritePointer(channel, startSample);
+        auto* history = delayBuffer.getWritePointer(channel);
+
+        if (limiting)
+            juce::FloatVectorOperations::multiply(output, history, gains.get(), numSamples);
+        else
+            juce::FloatVectorOperations::copy(output, history, numSamples);
+
+        // Keep the last `latency` samples around for the next chunk
+        std::memmove(history, history + numSamples, static_cast<size_t>(latency) * sizeof(float));
+    }
+}
+
+//==============================================================================
+void TruePeakLimiter::computePeaks (int numChannels, int numSamples)
+{
+    // peaks[i] is the largest magnitude, across channels and oversampled
+    // points, between input samples i - halfTaps and i - halfTaps + 1.
+    // Every phase is one vectorized pass per tap over the whole chunk.
+    juce::FloatVectorOperations::clear(peaks.get(), numSamples);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* input = delayBuffer.getReadPointer(channel, latency);
+
+        juce::FloatVectorOperations::abs(scratch.get(), input - halfTaps + 1, numSamples);
+        juce::FloatVectorOperations::max(peaks.get(), peaks.get(), scratch.get(), numSamples);
+
+        for (auto* coefs : phaseCoefs)
+        {
+            juce::FloatVectorOperations::clear(scratch.get(), numSamples);
+
+            for (int k = 0; k < tapsPerPhase; ++k)
+                juce::FloatVectorOperations::addWithMultiply(scratch.get(), input - k, coefs[k], numSamples);
+
+            juce::FloatVectorOperations::abs(scratch.get(), scratch.get(), numSamples);
+            juce::FloatVectorOperations::max(peaks.get(), peaks.get(), scratch.get(), numSamples);
+        }
+    }
+}
+
+bool TruePeakLimiter::computeGains (int numSamples)
+{
+    // Nothing to do while we're fully released and the chunk stays under the ceiling
+    if (envelope >= 1.0f && quietSamples > 2 * lookahead
+        && juce::FloatVectorOperations::findMaximum(peaks.get(), numSamples) <= ceiling)
+    {
+        minSize = 0;
+        rampSum = static_cast<double>(lookahead); // the ramp only holds 1s by now
+        sampleIndex += numSamples;
+        quietSamples = juce::jmin(quietSamples + numSamples, std::numeric_limits<int>::max() / 2);
+        return false;
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto target = peaks[i] > ceiling ? ceiling / peaks[i] : 1.0f;
+        quietSamples = target < 1.0f ? 0 : quietSamples + 1;
+
+        // Sliding minimum (monotonic queue in a fixed ring)
+        while (minSize > 0 && minValues[(minHead + minSize - 1) % minCapacity] >= target)
+            --minSize;
+
+        auto back = (minHead + minSize) % minCapacity;
+        minValues[back] = target;
+        minIndices[back] = sampleIndex;
+        ++minSize;
+
+        while (minIndices[minHead] < sampleIndex - lookahead)
+        {
+            minHead = (minHead + 1) % minCapacity;
+            --minSize;
+        }
+
+        // Averaging the held minimum over the lookahead reaches the target
+        // exactly when the peak leaves the delay line
+        auto held = minValues[minHead];
+        rampSum += held - rampValues[rampPos];
+        rampValues[rampPos] = held;
+        rampPos = (rampPos + 1) % lookahead;
+
+        auto ramp = juce::jmin(1.0f, static_cast<float>(rampSum / lookahead));
+
+        // Release can only slow the gain down on its way back up
+        envelope = ramp < envelope ? ramp : envelope + (ramp - envelope) * releaseCoef;
+
+        if (envelope > 0.9999f)
+            envelope = 1.0f;
+
+        gains[i] = envelope;
+        ++sampleIndex;
+    }
+
+    return true;
+}
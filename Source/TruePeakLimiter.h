@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    TruePeakLimiter.h
+
+    Safety limiter for the output stage. Looks ahead a couple of milliseconds
+    and estimates inter-sample peaks with a 4x polyphase interpolator, so the
+    output stays under the ceiling even when the feedback runs away.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+*/
+class TruePeakLimiter
+{
+public:
+    TruePeakLimiter();
+
+    //==============================================================================
+    void prepare (double sampleRate, int maximumBlockSize, int numChannels);
+    void reset();
+
+    // Limits the buffer in place (stereo linked). The output is delayed by
+    // getLatencyInSamples().
+    void process (juce::AudioBuffer<float>& buffer);
+
+    int getLatencyInSamples() const { return latency; }
+
+private:
+    //==============================================================================
+    void processChunk (juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+    void computePeaks (int numChannels, int numSamples);
+    bool computeGains (int numSamples);
+
+    static constexpr int oversampling = 4;
+    static constexpr int halfTaps = 4;
+    static constexpr int tapsPerPhase = 2 * halfTaps;
+
+    float phaseCoefs[oversampling - 1][tapsPerPhase];
+
+    float ceiling = juce::Decibels::decibelsToGain (-1.0f); // dBTP
+    float releaseCoef = 0.0f;
+    float envelope = 1.0f;
+
+    int lookahead = 0;      // length of the gain ramp, in samples
+    int latency = 0;        // lookahead plus the interpolator's group delay
+    int maxBlockSize = 0;
+    int quietSamples = 0;   // samples since the last one that needed gain reduction
+
+    // [latency samples of history | current chunk] per channel
+    juce::AudioBuffer<float> delayBuffer;
+
+    juce::HeapBlock<float> peaks;
+    juce::HeapBlock<float> scratch;
+    juce::HeapBlock<float> gains;
+
+    // Sliding minimum of the target gain over the last lookahead + 1 samples
+    juce::HeapBlock<float> minValues;
+    juce::HeapBlock<juce::int64> minIndices;
+    int minHead = 0, minSize = 0, minCapacity = 0;
+
+    // Moving average of the held gain, which turns the hold into a ramp
+    juce::HeapBlock<float> rampValues;
+    int rampPos = 0;
+    double rampSum = 0.0;
+
+    juce::int64 sampleIndex = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TruePeakLimiter)
+};